@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <random>
 
+#include "tracing.h"
+
 namespace sort {
 namespace impl {
 
@@ -32,23 +34,34 @@ void heapify(RandomAccessIterator begin, RandomAccessIterator end,
 
 }  // namespace impl
 
-template<class RandomAccessIterator, class Compare>
-void heap(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+template<class RandomAccessIterator, class Compare, class Tracer>
+void heap(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, Tracer tracer)
 {
     if (end - begin < 2u)
         return;
 
     // Building heap.
+    auto timer = tracer.start();
     for (auto it = begin + (end - begin) / 2; it != begin; --it)
         impl::heapify(begin, end, it, comp);
     impl::heapify(begin, end, begin, comp);
+    tracer.phase(tracing::Phase::HeapBuild, timer, end - begin);
 
     // Sorting, based on previously built heap. End iterator moving backwards during sorting.
+    timer = tracer.start();
+    const auto size = end - begin;
     while (end != begin) {
         std::iter_swap(begin, end - 1);
         --end;
         impl::heapify(begin, end, begin, comp);
     }
+    tracer.phase(tracing::Phase::HeapExtract, timer, size);
+}
+
+template<class RandomAccessIterator, class Compare>
+void heap(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+{
+    return heap(begin, end, comp, tracing::NoTracing());
 }
 
 template<class RandomAccessIterator>
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "merge.h"
+#include "quick.h"
+
+namespace sort {
+
+// Insert a batch of elements into the sorted vector without resorting it: the batch is sorted on its own and merged
+// into the data from the tail, so only elements greater than the batch minimum are moved. Insertion is stable: equal
+// elements are kept in the order of insertion.
+template<class ValueType, class RandomAccessIterator, class Compare>
+void insertBatch(std::vector<ValueType>& data, RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+{
+    std::vector<ValueType> batch(begin, end);
+    merge(batch.begin(), batch.end(), comp);
+    const auto old_size = data.size();
+    data.resize(old_size + batch.size());
+    impl::mergeFromTail(data.begin(), data.begin() + old_size, batch.begin(), batch.end(), comp);
+}
+
+template<class ValueType, class RandomAccessIterator>
+void insertBatch(std::vector<ValueType>& data, RandomAccessIterator begin, RandomAccessIterator end)
+{
+    return insertBatch(data, begin, end, std::less<ValueType>());
+}
+
+
+// Erase one element, equal to each of the batch elements, from the sorted vector. Data is compacted in a single pass,
+// starting from the first erased position. Batch elements, that are not present in data, are ignored.
+template<class ValueType, class RandomAccessIterator, class Compare>
+void eraseBatch(std::vector<ValueType>& data, RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+{
+    std::vector<ValueType> batch(begin, end);
+    if (batch.empty())
+        return;
+    quick(batch.begin(), batch.end(), comp);
+
+    auto erased = batch.begin();
+    auto kept = std::lower_bound(data.begin(), data.end(), *erased, comp);
+    for (auto it = kept; it != data.end(); ++it) {
+        // Skip batch elements, that are lesser than the current one: they are not present in data.
+        while (erased != batch.end() && comp(*erased, *it))
+            ++erased;
+        // All erased elements are found, the rest of data should be moved as is, if anything was erased.
+        if (erased == batch.end()) {
+            kept = kept != it ? std::move(it, data.end(), kept) : data.end();
+            break;
+        }
+        if (!comp(*it, *erased)) {
+            ++erased;
+            continue;
+        }
+        if (kept != it)
+            *kept = std::move(*it);
+        ++kept;
+    }
+    data.erase(kept, data.end());
+}
+
+template<class ValueType, class RandomAccessIterator>
+void eraseBatch(std::vector<ValueType>& data, RandomAccessIterator begin, RandomAccessIterator end)
+{
+    return eraseBatch(data, begin, end, std::less<ValueType>());
+}
+
+
+// Sorted multiset, stored as a sequence of small sorted blocks. Each insertion or deletion moves elements of a single
+// block only, and rank queries are answered with a Fenwick tree over block sizes. Equal elements are kept in the
+// order of insertion.
+template<class ValueType, class Compare = std::less<ValueType>>
+class SortedBlocks
+{
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ValueType value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const ValueType* pointer;
+        typedef const ValueType& reference;
+
+        const_iterator() : blocks_(nullptr), block_(0), offset_(0) {}
+
+        reference operator*() const { return (*blocks_)[block_][offset_]; }
+        pointer operator->() const { return &(*blocks_)[block_][offset_]; }
+
+        const_iterator& operator++()
+        {
+            if (++offset_ == (*blocks_)[block_].size()) {
+                ++block_;
+                offset_ = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return block_ == other.block_ && offset_ == other.offset_;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class SortedBlocks;
+
+        const_iterator(const std::vector<std::vector<ValueType>>* blocks, size_t block, size_t offset)
+            : blocks_(blocks), block_(block), offset_(offset) {}
+
+        const std::vector<std::vector<ValueType>>* blocks_;
+        size_t block_;
+        size_t offset_;
+    };
+
+    // Blocks, that grow larger than |block_size|, are split in halves.
+    explicit SortedBlocks(Compare comp = Compare(), size_t block_size = 512)
+        : comp_(comp), block_size_(std::max<size_t>(block_size, 2u)), size_(0) {}
+
+    size_t size() const { return size_; }
+    size_t blocksCount() const { return blocks_.size(); }
+    bool empty() const { return size_ == 0; }
+    const_iterator begin() const { return const_iterator(&blocks_, 0, 0); }
+    const_iterator end() const { return const_iterator(&blocks_, blocks_.size(), 0); }
+
+    void insert(const ValueType& value)
+    {
+        ++size_;
+        if (blocks_.empty()) {
+            blocks_.push_back(std::vector<ValueType>(1, value));
+            rebuildSizesTree();
+            return;
+        }
+
+        const size_t block = upperBlock(value, 0);
+        std::vector<ValueType>& data = blocks_[block];
+        data.insert(std::upper_bound(data.begin(), data.end(), value, comp_), value);
+        if (data.size() > block_size_) {
+            splitBlock(block);
+            rebuildSizesTree();
+        } else {
+            updateSizesTree(block, 1);
+        }
+    }
+
+    // Batch insertion: the batch is sorted, and each block receives its part of the batch with a single merge.
+    template<class RandomAccessIterator>
+    void insert(RandomAccessIterator begin, RandomAccessIterator end)
+    {
+        std::vector<ValueType> batch(begin, end);
+        if (batch.empty())
+            return;
+        // Stable sorting keeps equal batch elements in the order of insertion.
+        merge(batch.begin(), batch.end(), comp_);
+        size_ += batch.size();
+
+        if (blocks_.empty()) {
+            blocks_.push_back(std::move(batch));
+            splitBlock(0);
+            rebuildSizesTree();
+            return;
+        }
+
+        size_t block = 0;
+        for (auto inserted = batch.begin(); inserted != batch.end();) {
+            // Batch is sorted, so the next block is never before the previous one.
+            block = upperBlock(*inserted, block);
+            std::vector<ValueType>& data = blocks_[block];
+            // Elements, that are lesser than the block maximum, belong to the block. The last block takes the rest.
+            const auto inserted_end = block + 1 == blocks_.size()
+                ? batch.end() : std::lower_bound(inserted, batch.end(), data.back(), comp_);
+            const auto old_size = data.size();
+            data.resize(old_size + (inserted_end - inserted));
+            impl::mergeFromTail(data.begin(), data.begin() + old_size, inserted, inserted_end, comp_);
+            block = splitBlock(block);
+            inserted = inserted_end;
+        }
+        rebuildSizesTree();
+    }
+
+    // Erase one element, equal to |value|. Returns false, if there is no such element.
+    bool erase(const ValueType& value)
+    {
+        const size_t block = lowerBlock(value);
+        if (block == blocks_.size())
+            return false;
+        std::vector<ValueType>& data = blocks_[block];
+        const auto it = std::lower_bound(data.begin(), data.end(), value, comp_);
+        if (comp_(value, *it))
+            return false;
+
+        data.erase(it);
+        --size_;
+        if (data.empty() || data.size() < block_size_ / 4) {
+            mergeBlock(block);
+            rebuildSizesTree();
+        } else {
+            updateSizesTree(block, -1);
+        }
+        return true;
+    }
+
+    // Erase one element, equal to each of the batch elements. Returns count of erased elements.
+    template<class RandomAccessIterator>
+    size_t erase(RandomAccessIterator begin, RandomAccessIterator end)
+    {
+        size_t erased_count = 0;
+        for (auto it = begin; it != end; ++it) {
+            if (erase(*it))
+                ++erased_count;
+        }
+        return erased_count;
+    }
+
+    // Count of elements, that are lesser than |value|.
+    size_t rank(const ValueType& value) const
+    {
+        const size_t block = lowerBlock(value);
+        if (block == blocks_.size())
+            return size_;
+        const std::vector<ValueType>& data = blocks_[block];
+        return prefixSize(block) + (std::lower_bound(data.begin(), data.end(), value, comp_) - data.begin());
+    }
+
+    // Element, that would be on the k-th position in the sorted order, or end(), if k is out of range.
+    const_iterator k_statistics(size_t k) const
+    {
+        if (k >= size_)
+            return end();
+
+        // Descending the Fenwick tree: looking for count of blocks, that end not after k-th element.
+        size_t block = 0, step = 1;
+        while (step * 2 <= blocks_.size())
+            step *= 2;
+        for (; step != 0; step /= 2) {
+            if (block + step <= blocks_.size() && sizes_tree_[block + step] <= k) {
+                block += step;
+                k -= sizes_tree_[block];
+            }
+        }
+        return const_iterator(&blocks_, block, k);
+    }
+
+private:
+    static size_t lowestBit(size_t value) { return value & (~value + 1); }
+
+    // First block, starting from |from|, that has elements greater than |value|, or the last block.
+    size_t upperBlock(const ValueType& value, size_t from) const
+    {
+        const auto it = std::partition_point(blocks_.begin() + from, blocks_.end() - 1,
+            [this, &value](const std::vector<ValueType>& data) { return !comp_(value, data.back()); });
+        return it - blocks_.begin();
+    }
+
+    // First block, that has elements not lesser than |value|, or blocks count.
+    size_t lowerBlock(const ValueType& value) const
+    {
+        const auto it = std::partition_point(blocks_.begin(), blocks_.end(),
+            [this, &value](const std::vector<ValueType>& data) { return comp_(data.back(), value); });
+        return it - blocks_.begin();
+    }
+
+    // Split oversized block in parts, that are not larger than half of the block size. Returns index of the last part.
+    size_t splitBlock(size_t block)
+    {
+        const size_t size = blocks_[block].size();
+        if (size <= block_size_)
+            return block;
+
+        const size_t parts_count = (size + block_size_ / 2 - 1) / (block_size_ / 2);
+        std::vector<std::vector<ValueType>> parts(parts_count - 1);
+        std::vector<ValueType>& data = blocks_[block];
+        for (size_t i = 1; i < parts_count; ++i) {
+            parts[i - 1].assign(std::make_move_iterator(data.begin() + size * i / parts_count),
+                                std::make_move_iterator(data.begin() + size * (i + 1) / parts_count));
+        }
+        data.erase(data.begin() + size / parts_count, data.end());
+        blocks_.insert(blocks_.begin() + block + 1,
+                       std::make_move_iterator(parts.begin()), std::make_move_iterator(parts.end()));
+        return block + parts_count - 1;
+    }
+
+    // Merge underfull block with its neighbour, so blocks do not degrade into tiny vectors after erasing. Merged
+    // block is split back, if it becomes oversized.
+    void mergeBlock(size_t block)
+    {
+        if (blocks_.size() == 1) {
+            if (blocks_[0].empty())
+                blocks_.clear();
+            return;
+        }
+
+        const size_t first = block + 1 == blocks_.size() ? block - 1 : block;
+        std::vector<ValueType>& data = blocks_[first];
+        std::vector<ValueType>& next = blocks_[first + 1];
+        data.insert(data.end(), std::make_move_iterator(next.begin()), std::make_move_iterator(next.end()));
+        blocks_.erase(blocks_.begin() + first + 1);
+        splitBlock(first);
+    }
+
+    // Total size of blocks before the |block|.
+    size_t prefixSize(size_t block) const
+    {
+        size_t size = 0;
+        for (size_t i = block; i != 0; i -= lowestBit(i))
+            size += sizes_tree_[i];
+        return size;
+    }
+
+    void updateSizesTree(size_t block, int delta)
+    {
+        for (size_t i = block + 1; i < sizes_tree_.size(); i += lowestBit(i))
+            sizes_tree_[i] += delta;
+    }
+
+    void rebuildSizesTree()
+    {
+        sizes_tree_.assign(blocks_.size() + 1, 0u);
+        for (size_t i = 1; i < sizes_tree_.size(); ++i) {
+            sizes_tree_[i] += blocks_[i - 1].size();
+            const size_t parent = i + lowestBit(i);
+            if (parent < sizes_tree_.size())
+                sizes_tree_[parent] += sizes_tree_[i];
+        }
+    }
+
+    Compare comp_;
+    size_t block_size_;
+    size_t size_;
+    std::vector<std::vector<ValueType>> blocks_;
+    // Fenwick tree over block sizes, 1-based.
+    std::vector<size_t> sizes_tree_;
+};
+
+}  // namespace sort
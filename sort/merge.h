@@ -1,23 +1,28 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
 #include <vector>
 
+#include "tracing.h"
+
 namespace sort {
 namespace impl {
 
-template<class RandomAccessIterator, class ValueType, class Compare>
-void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, std::vector<ValueType>& buffer)
+template<class RandomAccessIterator, class ValueType, class Compare, class Tracer>
+void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, std::vector<ValueType>& buffer,
+           Tracer tracer)
 {
     if (end - begin < 2u)
         return;
 
     // Sorting begin-middle and middle-end subarrays.
     RandomAccessIterator middle = begin + (end - begin) / 2;
-    merge(begin, middle, comp, buffer);
-    merge(middle, end, comp, buffer);
+    merge(begin, middle, comp, buffer, tracer.nested());
+    merge(middle, end, comp, buffer, tracer.nested());
 
     // Merging results.
+    const auto timer = tracer.start();
     RandomAccessIterator merged_left = begin, merged_right = middle;
     auto merged_in_buffer = buffer.begin();
     while (merged_left != middle && merged_right != end) {
@@ -36,17 +41,58 @@ void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, s
     if (merged_left != middle)
         std::move_backward(merged_left, middle, end);
     std::move(buffer.begin(), merged_in_buffer, begin);
+    tracer.phase(tracing::Phase::Merge, timer, end - begin);
+}
+
+// Search for the first element in sorted [begin, end), that is greater than |value|, starting from the tail. Steps
+// are doubled until the bound is passed, so short tails are found in a few comparisons even in large ranges.
+template<class RandomAccessIterator, class ValueType, class Compare>
+RandomAccessIterator gallopFromTail(RandomAccessIterator begin, RandomAccessIterator end, const ValueType& value,
+                                    Compare comp)
+{
+    typename std::iterator_traits<RandomAccessIterator>::difference_type checked = 0, step = 1;
+    while (step <= end - begin && comp(value, *(end - step))) {
+        checked = step;
+        step <<= 1;
+    }
+    // All elements after end - checked are greater than value, and the element on end - step is not.
+    return std::upper_bound(step <= end - begin ? end - step : begin, end - checked, value, comp);
+}
+
+// Merging sorted [begin, middle) with sorted buffer elements in place, from the tail. There should be enough space
+// for the buffer elements after the middle. Runs of the first subarray are found by galloping and moved as a whole,
+// so merging a small buffer into a large array costs only a few comparisons per buffer element. Merging is stable:
+// buffer elements are placed after equal elements of the first subarray.
+template<class RandomAccessIterator, class BufferIterator, class Compare>
+void mergeFromTail(RandomAccessIterator begin, RandomAccessIterator middle,
+                   BufferIterator buffer_begin, BufferIterator buffer_end, Compare comp)
+{
+    RandomAccessIterator merged = middle + (buffer_end - buffer_begin);
+    while (buffer_end != buffer_begin) {
+        --buffer_end;
+        RandomAccessIterator run_begin = gallopFromTail(begin, middle, *buffer_end, comp);
+        merged = std::move_backward(run_begin, middle, merged);
+        middle = run_begin;
+        --merged;
+        *merged = std::move(*buffer_end);
+    }
 }
 
 }  // namespace impl
 
-template<class RandomAccessIterator, class Compare>
-void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+template<class RandomAccessIterator, class Compare, class Tracer>
+void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, Tracer tracer)
 {
     if (end - begin < 2u)
         return;
     std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type> buffer(end - begin);
-    impl::merge(begin, end, comp, buffer);
+    impl::merge(begin, end, comp, buffer, tracer);
+}
+
+template<class RandomAccessIterator, class Compare>
+void merge(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+{
+    return merge(begin, end, comp, tracing::NoTracing());
 }
 
 template<class RandomAccessIterator>
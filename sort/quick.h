@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <random>
 
+#include "tracing.h"
+
 namespace sort {
 namespace impl {
 
@@ -46,25 +48,33 @@ void threeWaySplit(RandomAccessIterator begin, RandomAccessIterator end, Compare
     }
 }
 
-template<class RandomAccessIterator, class Compare>
-void quick(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
+template<class RandomAccessIterator, class Compare, class Tracer>
+void quick(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, Tracer tracer)
 {
     if (end - begin < 2u)
         return;
     RandomAccessIterator equal_begin, greater_begin;
     // Divide elements on subarrays.
+    const auto timer = tracer.start();
     threeWaySplit(begin, end, comp, equal_begin, greater_begin);
+    tracer.partition(timer, equal_begin - begin, greater_begin - equal_begin, end - greater_begin);
     // Sorting subarrays with elements, that are lesser or greater than the base one.
-    quick(begin, equal_begin, comp);
-    quick(greater_begin, end, comp);
+    quick(begin, equal_begin, comp, tracer.nested());
+    quick(greater_begin, end, comp, tracer.nested());
 }
 
 }  // namespace impl
 
+template<class RandomAccessIterator, class Compare, class Tracer>
+void quick(RandomAccessIterator begin, RandomAccessIterator end, Compare comp, Tracer tracer)
+{
+    impl::quick(begin, end, comp, tracer);
+}
+
 template<class RandomAccessIterator, class Compare>
 void quick(RandomAccessIterator begin, RandomAccessIterator end, Compare comp)
 {
-    impl::quick(begin, end, comp);
+    impl::quick(begin, end, comp, tracing::NoTracing());
 }
 
 template<class RandomAccessIterator>
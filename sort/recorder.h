@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "tracing.h"
+
+// Recording tracing policy. Only users, that trace sorting, should include this header.
+namespace sort {
+namespace tracing {
+
+struct Event
+{
+    Phase phase;
+    // Index of the thread, that recorded the event, in order of first recording.
+    unsigned thread;
+    // Recursion depth of the call.
+    unsigned depth;
+    // Count of elements, processed in the phase.
+    size_t size;
+    // Sizes of lesser, equal and greater parts for partitions, zeroes for other phases.
+    size_t lesser, equal, greater;
+    // Phase start since the first Recorder construction in the process, and its duration.
+    int64_t start_ns, duration_ns;
+};
+
+namespace impl {
+
+// Events of a single thread. Only the owning thread appends to it, so recording does not need any synchronization.
+struct TraceBuffer
+{
+    unsigned thread;
+    std::vector<Event> events;
+};
+
+// All thread buffers. The mutex protects the list itself and is taken only once per thread and during dumps, which
+// should not run concurrently with traced sorting.
+struct TraceRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+inline TraceRegistry& traceRegistry()
+{
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline TraceBuffer& traceBuffer()
+{
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceRegistry& registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.emplace_back(new TraceBuffer());
+        buffer = registry.buffers.back().get();
+        buffer->thread = static_cast<unsigned>(registry.buffers.size() - 1);
+    }
+    return *buffer;
+}
+
+}  // namespace impl
+
+class Recorder
+{
+public:
+    typedef std::chrono::steady_clock::time_point Timer;
+
+    // Registry is initialized here, so it always exists before the first timer is started.
+    Recorder() : depth_(0) { impl::traceRegistry(); }
+
+    Timer start() const { return std::chrono::steady_clock::now(); }
+
+    Recorder nested() const
+    {
+        Recorder result;
+        result.depth_ = depth_ + 1;
+        return result;
+    }
+
+    void partition(const Timer& timer, size_t lesser, size_t equal, size_t greater) const
+    {
+        record(Phase::Partition, timer, lesser + equal + greater, lesser, equal, greater);
+    }
+
+    void phase(Phase phase, const Timer& timer, size_t size) const
+    {
+        record(phase, timer, size, 0, 0, 0);
+    }
+
+    // Events of all threads, ordered by start time.
+    static std::vector<Event> events()
+    {
+        impl::TraceRegistry& registry = impl::traceRegistry();
+        std::vector<Event> result;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (const auto& buffer : registry.buffers)
+                result.insert(result.end(), buffer->events.begin(), buffer->events.end());
+        }
+        std::stable_sort(result.begin(), result.end(),
+                         [](const Event& first, const Event& second) { return first.start_ns < second.start_ns; });
+        return result;
+    }
+
+    static void clear()
+    {
+        impl::TraceRegistry& registry = impl::traceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers)
+            buffer->events.clear();
+    }
+
+    // Complete ("X") events in Chrome trace format, with partition sizes and recursion depth as arguments.
+    static void dumpChromeTrace(std::ostream& output)
+    {
+        // Timestamps are in microseconds, fixed notation keeps nanosecond resolution for long-running processes.
+        const std::ios_base::fmtflags flags = output.flags();
+        const std::streamsize precision = output.precision();
+        output << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+        bool first = true;
+        for (const Event& event : events()) {
+            output << (first ? "\n" : ",\n") << "{\"name\":\"" << phaseName(event.phase) << "\",\"ph\":\"X\""
+                   << ",\"pid\":0,\"tid\":" << event.thread
+                   << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0
+                   << ",\"args\":{\"depth\":" << event.depth << ",\"size\":" << event.size;
+            if (event.phase == Phase::Partition) {
+                output << ",\"lesser\":" << event.lesser << ",\"equal\":" << event.equal
+                       << ",\"greater\":" << event.greater;
+            }
+            output << "}}";
+            first = false;
+        }
+        output << "\n]}" << std::endl;
+        output.flags(flags);
+        output.precision(precision);
+    }
+
+    // One "key value" pair per line: time and calls per phase, maximal recursion depth, share of sorted elements, that
+    // duplicate another element, and histogram of the smaller side share of partitions in 5% steps.
+    static void dumpSummary(std::ostream& output)
+    {
+        const unsigned kPhasesCount = 4, kBalanceBuckets = 10;
+        int64_t phase_ns[kPhasesCount] = {};
+        size_t phase_calls[kPhasesCount] = {};
+        size_t balance[kBalanceBuckets] = {};
+        size_t sorted = 0, duplicated = 0;
+        unsigned max_depth = 0;
+        for (const Event& event : events()) {
+            phase_ns[static_cast<unsigned>(event.phase)] += event.duration_ns;
+            ++phase_calls[static_cast<unsigned>(event.phase)];
+            max_depth = std::max(max_depth, event.depth);
+            if (event.phase == Phase::Partition) {
+                // Elements are counted once per sorting, in the top-level partition.
+                if (event.depth == 0)
+                    sorted += event.size;
+                // Equal elements are excluded from further partitioning, so each value is the base element only once
+                // and all of its copies are counted here, except the base element itself.
+                duplicated += event.equal - 1;
+                // Smaller side of perfectly balanced partition has 50% of elements.
+                const size_t smaller_side = std::min(event.lesser, event.greater);
+                ++balance[std::min<size_t>(smaller_side * 2 * kBalanceBuckets / event.size, kBalanceBuckets - 1)];
+            }
+        }
+
+        for (unsigned i = 0; i < kPhasesCount; ++i) {
+            const char* name = phaseName(static_cast<Phase>(i));
+            output << name << "_calls " << phase_calls[i] << "\n" << name << "_us " << phase_ns[i] / 1000 << "\n";
+        }
+        output << "max_depth " << max_depth << "\n";
+        output << "duplicate_ratio " << (sorted ? static_cast<double>(duplicated) / sorted : 0.0) << "\n";
+        for (unsigned i = 0; i < kBalanceBuckets; ++i)
+            output << "partition_balance_" << i * 5 << "_" << (i + 1) * 5 << " " << balance[i] << "\n";
+        output.flush();
+    }
+
+private:
+    void record(Phase phase, const Timer& timer, size_t size, size_t lesser, size_t equal, size_t greater) const
+    {
+        const Timer now = std::chrono::steady_clock::now();
+        impl::TraceBuffer& buffer = impl::traceBuffer();
+        const Event event = {
+            phase, buffer.thread, depth_, size, lesser, equal, greater,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timer - impl::traceRegistry().epoch).count(),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - timer).count()};
+        buffer.events.push_back(event);
+    }
+
+    unsigned depth_;
+};
+
+}  // namespace tracing
+}  // namespace sort
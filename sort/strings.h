@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "quick.h"
+
+// String-specialized sorting engines. All of them order strings lexicographically by unsigned characters, exactly
+// like std::less<std::string>, and accept ranges of std::string, std::string_view (C++17) and C strings.
+namespace sort {
+namespace impl {
+
+// Ranges shorter than this are finished with insertion sort.
+const ptrdiff_t kStringInsertionThreshold = 16;
+
+// Sorting key for a single string. The first 8 bytes are cached inline, so most comparisons on the upper levels of
+// sorting do not dereference string data at all.
+struct StringKey
+{
+    // First 8 bytes of the string, big-endian, zero-padded.
+    uint64_t prefix;
+    const unsigned char* data;
+    size_t length;
+    // Position of the string in the original range.
+    size_t index;
+    // Length of the common prefix with the previous key in the sorted run (used by LCP merge sort only).
+    size_t lcp;
+};
+
+inline StringKey makeStringKey(const unsigned char* data, size_t length, size_t index)
+{
+    StringKey key = {0u, data, length, index, 0u};
+    for (size_t i = 0; i < 8; ++i)
+        key.prefix = (key.prefix << 8) | (i < length ? data[i] : 0u);
+    return key;
+}
+
+inline StringKey makeStringKey(const std::string& value, size_t index)
+{
+    return makeStringKey(reinterpret_cast<const unsigned char*>(value.data()), value.size(), index);
+}
+
+inline StringKey makeStringKey(const char* value, size_t index)
+{
+    return makeStringKey(reinterpret_cast<const unsigned char*>(value), std::strlen(value), index);
+}
+
+#if __cplusplus >= 201703L
+inline StringKey makeStringKey(std::string_view value, size_t index)
+{
+    return makeStringKey(reinterpret_cast<const unsigned char*>(value.data()), value.size(), index);
+}
+#endif
+
+inline unsigned prefixByte(uint64_t prefix, size_t position)
+{
+    return static_cast<unsigned>(prefix >> (56 - 8 * position)) & 0xffu;
+}
+
+// Character of the key on the given position, or -1, if the string is already ended.
+inline int charAt(const StringKey& key, size_t depth)
+{
+    if (depth >= key.length)
+        return -1;
+    return depth < 8 ? static_cast<int>(prefixByte(key.prefix, depth)) : key.data[depth];
+}
+
+// Compare two keys, that are known to have at least |depth| common first characters. Returns negative, zero or
+// positive value, like strcmp, and stores the length of the common prefix into |lcp|.
+inline int compareFrom(const StringKey& first, const StringKey& second, size_t depth, size_t& lcp)
+{
+    if (depth < 8) {
+        // Differing cached prefixes are enough to order strings: zero padding can only be compared with a non-zero
+        // character, and the shorter string is lesser in that case.
+        if (first.prefix != second.prefix) {
+            while (prefixByte(first.prefix, depth) == prefixByte(second.prefix, depth))
+                ++depth;
+            // Padding of the shorter string could match zero characters of the longer one.
+            lcp = std::min(depth, std::min(first.length, second.length));
+            return prefixByte(first.prefix, depth) < prefixByte(second.prefix, depth) ? -1 : 1;
+        }
+        depth = std::min<size_t>(8u, std::min(first.length, second.length));
+    }
+
+    const size_t common_length = std::min(first.length, second.length);
+    while (depth < common_length && first.data[depth] == second.data[depth])
+        ++depth;
+    lcp = depth;
+    if (depth == common_length)
+        return first.length == second.length ? 0 : (first.length < second.length ? -1 : 1);
+    return first.data[depth] < second.data[depth] ? -1 : 1;
+}
+
+// Insertion sort for keys, that are known to have at least |depth| common first characters.
+inline void insertionFrom(StringKey* begin, StringKey* end, size_t depth)
+{
+    size_t lcp;
+    for (StringKey* sorted = begin + 1; sorted < end; ++sorted) {
+        for (StringKey* current = sorted; current != begin && compareFrom(*current, *(current - 1), depth, lcp) < 0;
+             --current)
+            std::swap(*current, *(current - 1));
+    }
+}
+
+// Multikey quicksort: three-way split by a single character, then the equal part is sorted by the next one. The
+// largest part is sorted in the loop and the others recursively, so recursion depth does not depend on the length of
+// common prefixes.
+inline void multikeyQuick(StringKey* begin, StringKey* end, size_t depth)
+{
+    while (end - begin >= kStringInsertionThreshold) {
+        StringKey *equal_begin, *greater_begin;
+        threeWaySplit(begin, end,
+                      [depth](const StringKey& first, const StringKey& second) {
+                          return charAt(first, depth) < charAt(second, depth);
+                      },
+                      equal_begin, greater_begin);
+
+        // Equal subarray always contains the base element. If all of its strings are ended, they are equal.
+        const bool equal_ended = charAt(*equal_begin, depth) < 0;
+        const ptrdiff_t lesser_size = equal_begin - begin, greater_size = end - greater_begin;
+        const ptrdiff_t equal_size = greater_begin - equal_begin;
+        if (!equal_ended && equal_size >= lesser_size && equal_size >= greater_size) {
+            multikeyQuick(begin, equal_begin, depth);
+            multikeyQuick(greater_begin, end, depth);
+            begin = equal_begin;
+            end = greater_begin;
+            ++depth;
+        } else if (lesser_size >= greater_size) {
+            if (!equal_ended)
+                multikeyQuick(equal_begin, greater_begin, depth + 1);
+            multikeyQuick(greater_begin, end, depth);
+            end = equal_begin;
+        } else {
+            multikeyQuick(begin, equal_begin, depth);
+            if (!equal_ended)
+                multikeyQuick(equal_begin, greater_begin, depth + 1);
+            begin = greater_begin;
+        }
+    }
+    insertionFrom(begin, end, depth);
+}
+
+// MSD radix sort. Characters of the current position are computed once per level and cached in |chars|, bucket 0
+// is reserved for strings, that are already ended. Like in multikey quicksort, the largest bucket is sorted in the
+// loop, so only buckets with at most half of the keys are sorted recursively.
+inline void msdRadix(StringKey* begin, StringKey* end, size_t depth, StringKey* buffer, uint16_t* chars)
+{
+    size_t bucket_sizes[257], bucket_positions[257];
+    while (end - begin >= kStringInsertionThreshold) {
+        const size_t size = end - begin;
+        std::fill(bucket_sizes, bucket_sizes + 257, 0u);
+        for (size_t i = 0; i < size; ++i) {
+            chars[i] = static_cast<uint16_t>(charAt(begin[i], depth) + 1);
+            ++bucket_sizes[chars[i]];
+        }
+        // Common character for all strings: there is nothing to distribute, go to the next one.
+        if (bucket_sizes[chars[0]] == size) {
+            if (chars[0] == 0)
+                return;
+            ++depth;
+            continue;
+        }
+
+        // Distributing keys through the buffer.
+        bucket_positions[0] = 0;
+        for (size_t i = 1; i < 257; ++i)
+            bucket_positions[i] = bucket_positions[i - 1] + bucket_sizes[i - 1];
+        for (size_t i = 0; i < size; ++i)
+            buffer[bucket_positions[chars[i]]++] = begin[i];
+        std::copy(buffer, buffer + size, begin);
+
+        // Sorting buckets by the next character. Ended strings are equal and already placed first.
+        size_t largest = 1;
+        for (size_t i = 2; i < 257; ++i) {
+            if (bucket_sizes[i] > bucket_sizes[largest])
+                largest = i;
+        }
+        StringKey *bucket_begin = begin + bucket_sizes[0], *largest_begin = bucket_begin;
+        for (size_t i = 1; i < 257; ++i) {
+            if (i == largest)
+                largest_begin = bucket_begin;
+            else if (bucket_sizes[i] > 1)
+                msdRadix(bucket_begin, bucket_begin + bucket_sizes[i], depth + 1, buffer, chars);
+            bucket_begin += bucket_sizes[i];
+        }
+        begin = largest_begin;
+        end = largest_begin + bucket_sizes[largest];
+        ++depth;
+    }
+    insertionFrom(begin, end, depth);
+}
+
+// Stable merge sort, that keeps the longest common prefix of each key with its predecessor. During merging, keys
+// with different LCP with the last merged key are ordered without looking into the strings at all, and equal LCPs
+// let comparison skip the known common prefix.
+inline void lcpMerge(StringKey* begin, StringKey* end, StringKey* buffer)
+{
+    if (end - begin < 2)
+        return;
+
+    // Sorting begin-middle and middle-end subarrays.
+    StringKey* middle = begin + (end - begin) / 2;
+    lcpMerge(begin, middle, buffer);
+    lcpMerge(middle, end, buffer);
+
+    // Merging results. LCP values are calculated relatively to the last merged key.
+    StringKey *merged_left = begin, *merged_right = middle, *merged_in_buffer = buffer;
+    size_t left_lcp = 0, right_lcp = 0, lcp;
+    while (merged_left != middle && merged_right != end) {
+        if (left_lcp > right_lcp ||
+            (left_lcp == right_lcp && compareFrom(*merged_left, *merged_right, left_lcp, lcp) <= 0)) {
+            // If the right key was compared, its LCP with the merged left key is known now.
+            if (left_lcp == right_lcp)
+                right_lcp = lcp;
+            *merged_in_buffer = *merged_left;
+            merged_in_buffer->lcp = left_lcp;
+            ++merged_left;
+            left_lcp = merged_left != middle ? merged_left->lcp : 0u;
+        } else {
+            if (left_lcp == right_lcp)
+                left_lcp = lcp;
+            *merged_in_buffer = *merged_right;
+            merged_in_buffer->lcp = right_lcp;
+            ++merged_right;
+            right_lcp = merged_right != end ? merged_right->lcp : 0u;
+        }
+        ++merged_in_buffer;
+    }
+
+    // Rest of the right subarray is already in the end of the sorted data, left subarray tail should be moved
+    // directly. Either way, the first key of the tail follows the last merged key now.
+    if (merged_left != middle) {
+        merged_left->lcp = left_lcp;
+        std::copy_backward(merged_left, middle, end);
+    } else if (merged_right != end) {
+        merged_right->lcp = right_lcp;
+    }
+    std::copy(buffer, merged_in_buffer, begin);
+}
+
+template<class RandomAccessIterator>
+std::vector<StringKey> makeStringKeys(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    std::vector<StringKey> keys;
+    keys.reserve(end - begin);
+    for (auto it = begin; it != end; ++it)
+        keys.push_back(makeStringKey(*it, keys.size()));
+    return keys;
+}
+
+// Reorder the original range in the order of sorted keys.
+template<class RandomAccessIterator>
+void applyStringKeys(RandomAccessIterator begin, RandomAccessIterator end, const std::vector<StringKey>& keys)
+{
+    std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type> sorted;
+    sorted.reserve(end - begin);
+    for (const StringKey& key : keys)
+        sorted.push_back(std::move(*(begin + key.index)));
+    std::move(sorted.begin(), sorted.end(), begin);
+}
+
+}  // namespace impl
+
+// Three-way radix quicksort (multikey quicksort).
+template<class RandomAccessIterator>
+void multikeyQuick(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (end - begin < 2u)
+        return;
+    std::vector<impl::StringKey> keys = impl::makeStringKeys(begin, end);
+    impl::multikeyQuick(keys.data(), keys.data() + keys.size(), 0u);
+    impl::applyStringKeys(begin, end, keys);
+}
+
+// Most significant digit first radix sort.
+template<class RandomAccessIterator>
+void msdRadix(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (end - begin < 2u)
+        return;
+    std::vector<impl::StringKey> keys = impl::makeStringKeys(begin, end);
+    std::vector<impl::StringKey> buffer(keys.size());
+    std::vector<uint16_t> chars(keys.size());
+    impl::msdRadix(keys.data(), keys.data() + keys.size(), 0u, buffer.data(), chars.data());
+    impl::applyStringKeys(begin, end, keys);
+}
+
+// Stable merge sort with longest common prefixes tracking.
+template<class RandomAccessIterator>
+void lcpMerge(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (end - begin < 2u)
+        return;
+    std::vector<impl::StringKey> keys = impl::makeStringKeys(begin, end);
+    std::vector<impl::StringKey> buffer(keys.size());
+    impl::lcpMerge(keys.data(), keys.data() + keys.size(), buffer.data());
+    impl::applyStringKeys(begin, end, keys);
+}
+
+}  // namespace sort
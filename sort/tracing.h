@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+// Tracing policies for the sorting engines. Engines call policy hooks around their internal phases and pass a nested
+// policy into recursive calls. NoTracing hooks are empty and are optimized out completely. Recorder from recorder.h
+// stores events into per-thread buffers, that can be dumped as Chrome trace JSON (chrome://tracing) or as a text
+// summary.
+namespace sort {
+namespace tracing {
+
+enum class Phase { Partition, Merge, HeapBuild, HeapExtract };
+
+inline const char* phaseName(Phase phase)
+{
+    switch (phase) {
+    case Phase::Partition:
+        return "partition";
+    case Phase::Merge:
+        return "merge";
+    case Phase::HeapBuild:
+        return "heap_build";
+    case Phase::HeapExtract:
+        return "heap_extract";
+    }
+    return "unknown";
+}
+
+class NoTracing
+{
+public:
+    struct Timer {};
+
+    Timer start() const { return Timer(); }
+    NoTracing nested() const { return NoTracing(); }
+    void partition(const Timer&, size_t, size_t, size_t) const {}
+    void phase(Phase, const Timer&, size_t) const {}
+};
+
+}  // namespace tracing
+}  // namespace sort
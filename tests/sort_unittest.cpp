@@ -1,16 +1,21 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "sort/basic.h"
 #include "sort/heap.h"
+#include "sort/incremental.h"
 #include "sort/merge.h"
+#include "sort/recorder.h"
 #include "sort/shuffle.h"
 #include "sort/statistics.h"
+#include "sort/strings.h"
 #include "sort/quick.h"
 
 class SortingTest : public ::testing::Test,
@@ -318,3 +323,430 @@ TEST_P(KStatisticsSortingTest, Basic)
     sort::quick(data_.begin(), data_.end());
     EXPECT_EQ(original_data_, data_);
 }
+
+// Test string sorting.
+class StringSortingTest : public SortingTest
+{
+protected:
+    void prepareSortingTest()
+    {
+        std::ifstream input_stream(GetParam(), std::istream::in);
+        int N;
+        input_stream >> N;
+        ASSERT_GT(N, 0);
+
+        original_data_.resize(N);
+        for (int i = 0; i < N; ++i)
+            input_stream >> original_data_[i];
+        input_stream.close();
+        data_ = original_data_;
+        startMeasurement();
+    }
+
+    void checkSorting()
+    {
+        endMeasurement();
+        std::sort(original_data_.begin(), original_data_.end());
+        EXPECT_EQ(original_data_, data_);
+    }
+
+    std::vector<std::string> data_;
+    std::vector<std::string> original_data_;
+};
+
+INSTANTIATE_TEST_CASE_P(StringInput, StringSortingTest,
+                        ::testing::Values("data/sorting/strings_duplicated.txt",
+                                          "data/sorting/strings_mixed.txt",
+                                          "data/sorting/strings_long.txt",
+                                          "data/sorting/single_number.txt"));
+
+TEST_P(StringSortingTest, MultikeyQuicksort)
+{
+    prepareSortingTest();
+    sort::multikeyQuick(data_.begin(), data_.end());
+    checkSorting();
+}
+
+TEST_P(StringSortingTest, MsdRadix)
+{
+    prepareSortingTest();
+    sort::msdRadix(data_.begin(), data_.end());
+    checkSorting();
+}
+
+TEST_P(StringSortingTest, LcpMerge)
+{
+    prepareSortingTest();
+    sort::lcpMerge(data_.begin(), data_.end());
+    checkSorting();
+}
+
+TEST_P(StringSortingTest, CStrings)
+{
+    prepareSortingTest();
+    std::vector<const char*> c_strings;
+    for (const std::string& value : original_data_)
+        c_strings.push_back(value.c_str());
+    sort::multikeyQuick(c_strings.begin(), c_strings.end());
+    data_.assign(c_strings.begin(), c_strings.end());
+    sort::shuffle(c_strings.begin(), c_strings.end());
+    sort::msdRadix(c_strings.begin(), c_strings.end());
+    EXPECT_TRUE(std::equal(data_.begin(), data_.end(), c_strings.begin()));
+    sort::shuffle(c_strings.begin(), c_strings.end());
+    sort::lcpMerge(c_strings.begin(), c_strings.end());
+    EXPECT_TRUE(std::equal(data_.begin(), data_.end(), c_strings.begin()));
+    checkSorting();
+}
+
+TEST(StringEdgeCasesTest, EmbeddedNulls)
+{
+    const char* samples[] = {"", "\0aabbaba", "a\0baaaa", "a", "aaa\0a", "bb\0\0abb", "a\0b", "a\0", "\0"};
+    const size_t lengths[] = {0, 9, 8, 1, 6, 8, 3, 2, 1};
+    std::vector<std::string> expected_data;
+    for (int copy = 0; copy < 8; ++copy) {
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+            expected_data.push_back(std::string(samples[i], lengths[i]));
+    }
+    std::srand(42u);
+    sort::shuffle(expected_data.begin(), expected_data.end());
+    std::vector<std::string> multikey_data = expected_data, radix_data = expected_data, merge_data = expected_data;
+    std::sort(expected_data.begin(), expected_data.end());
+
+    sort::multikeyQuick(multikey_data.begin(), multikey_data.end());
+    EXPECT_EQ(expected_data, multikey_data);
+    sort::msdRadix(radix_data.begin(), radix_data.end());
+    EXPECT_EQ(expected_data, radix_data);
+    sort::lcpMerge(merge_data.begin(), merge_data.end());
+    EXPECT_EQ(expected_data, merge_data);
+
+    // Short input is sorted by the insertion sort only, and LCP merge sort relies on LCPs from it.
+    std::vector<std::string> short_data;
+    for (size_t i : {1, 2, 3, 4, 5, 3})
+        short_data.push_back(std::string(samples[i], lengths[i]));
+    std::vector<std::string> expected_short_data = short_data;
+    std::sort(expected_short_data.begin(), expected_short_data.end());
+    sort::lcpMerge(short_data.begin(), short_data.end());
+    EXPECT_EQ(expected_short_data, short_data);
+}
+
+TEST(StringEdgeCasesTest, LongCommonPrefixes)
+{
+    // Recursion depth should not grow with the length of common prefixes.
+    std::vector<std::string> identical_data(100, std::string(100000, 'x'));
+    std::vector<std::string> nested_data;
+    for (size_t i = 1; i <= 5000; ++i)
+        nested_data.push_back(std::string(i, 'x'));
+    std::srand(42u);
+    sort::shuffle(nested_data.begin(), nested_data.end());
+
+    std::vector<std::string> expected_identical_data = identical_data, expected_nested_data = nested_data;
+    std::sort(expected_nested_data.begin(), expected_nested_data.end());
+
+    std::vector<std::string> data = identical_data;
+    sort::multikeyQuick(data.begin(), data.end());
+    EXPECT_EQ(expected_identical_data, data);
+    data = identical_data;
+    sort::msdRadix(data.begin(), data.end());
+    EXPECT_EQ(expected_identical_data, data);
+    data = identical_data;
+    sort::lcpMerge(data.begin(), data.end());
+    EXPECT_EQ(expected_identical_data, data);
+
+    data = nested_data;
+    sort::multikeyQuick(data.begin(), data.end());
+    EXPECT_EQ(expected_nested_data, data);
+    data = nested_data;
+    sort::msdRadix(data.begin(), data.end());
+    EXPECT_EQ(expected_nested_data, data);
+    data = nested_data;
+    sort::lcpMerge(data.begin(), data.end());
+    EXPECT_EQ(expected_nested_data, data);
+}
+
+// Test incremental sorting.
+class IncrementalSortingTest : public SortingTest
+{
+protected:
+    void prepareTest()
+    {
+        std::ifstream input_stream(GetParam(), std::istream::in);
+        int N;
+        input_stream >> N;
+        ASSERT_GT(N, 0);
+
+        original_data_.resize(N);
+        for (int i = 0; i < N; ++i)
+            input_stream >> original_data_[i];
+        input_stream.close();
+        // Half of the data is sorted initially, the rest comes in batches.
+        data_.assign(original_data_.begin(), original_data_.begin() + N / 2);
+        sort::quick(data_.begin(), data_.end());
+        expected_data_ = original_data_;
+        sort::quick(expected_data_.begin(), expected_data_.end());
+    }
+
+    const size_t kBatchSize = 64;
+    std::vector<int> data_;
+    std::vector<int> expected_data_;
+    std::vector<int> original_data_;
+};
+
+INSTANTIATE_TEST_CASE_P(IntegerInput, IncrementalSortingTest,
+                        ::testing::Values("data/sorting/all_duplicates.txt",
+                                          "data/sorting/highly_dispersed.txt",
+                                          "data/sorting/highly_duplicated.txt",
+                                          "data/sorting/rarely_duplicated.txt",
+                                          "data/sorting/single_number.txt",
+                                          "data/sorting/unique_1.txt",
+                                          "data/sorting/unique_2.txt",
+                                          "data/sorting/unique_3.txt"));
+
+TEST_P(IncrementalSortingTest, InsertBatch)
+{
+    prepareTest();
+    std::vector<int> resorted_data = data_;
+
+    // Resorting all data after each batch, for comparison.
+    std::cout << "Resorting:" << std::endl;
+    startMeasurement();
+    for (size_t i = data_.size(); i < original_data_.size(); i += kBatchSize) {
+        const size_t batch_end = std::min(i + kBatchSize, original_data_.size());
+        resorted_data.insert(resorted_data.end(), original_data_.begin() + i, original_data_.begin() + batch_end);
+        sort::quick(resorted_data.begin(), resorted_data.end());
+    }
+    endMeasurement();
+
+    std::cout << "Batch insertion:" << std::endl;
+    startMeasurement();
+    for (size_t i = data_.size(); i < original_data_.size(); i += kBatchSize) {
+        const size_t batch_end = std::min(i + kBatchSize, original_data_.size());
+        sort::insertBatch(data_, original_data_.begin() + i, original_data_.begin() + batch_end);
+    }
+    endMeasurement();
+
+    EXPECT_EQ(expected_data_, resorted_data);
+    EXPECT_EQ(expected_data_, data_);
+}
+
+TEST_P(IncrementalSortingTest, EraseBatch)
+{
+    prepareTest();
+    // Erase the second half of the data back, and a few elements, that were never inserted.
+    std::vector<int> erased(original_data_.begin() + original_data_.size() / 2, original_data_.end());
+    erased.push_back(-1);
+    sort::shuffle(erased.begin(), erased.end());
+    std::vector<int> expected_data = data_;
+    data_ = expected_data_;
+
+    startMeasurement();
+    for (size_t i = 0; i < erased.size(); i += kBatchSize)
+        sort::eraseBatch(data_, erased.begin() + i, erased.begin() + std::min(i + kBatchSize, erased.size()));
+    endMeasurement();
+    EXPECT_EQ(expected_data, data_);
+}
+
+TEST(IncrementalEdgeCasesTest, EraseBatchAbsent)
+{
+    // Nothing is erased, so elements should not be moved onto themselves.
+    const std::vector<std::string> expected_data = {std::string(32, 'b'), std::string(32, 'c')};
+    std::vector<std::string> data = expected_data;
+    const std::vector<std::string> erased = {"a"};
+    sort::eraseBatch(data, erased.begin(), erased.end());
+    EXPECT_EQ(expected_data, data);
+
+    const std::vector<std::string> erased_present = {"a", std::string(32, 'b')};
+    sort::eraseBatch(data, erased_present.begin(), erased_present.end());
+    EXPECT_EQ(std::vector<std::string>(1, std::string(32, 'c')), data);
+}
+
+TEST_P(IncrementalSortingTest, SortedBlocks)
+{
+    prepareTest();
+    sort::SortedBlocks<int> blocks(std::less<int>(), 64);
+    blocks.insert(data_.begin(), data_.end());
+
+    // Inserting the rest of the data in batches and one by one.
+    startMeasurement();
+    for (size_t i = data_.size(); i < original_data_.size(); i += kBatchSize) {
+        const size_t batch_end = std::min(i + kBatchSize, original_data_.size());
+        if (i / kBatchSize % 2)
+            blocks.insert(original_data_.begin() + i, original_data_.begin() + batch_end);
+        for (size_t j = i; j < batch_end && i / kBatchSize % 2 == 0; ++j)
+            blocks.insert(original_data_[j]);
+    }
+    endMeasurement();
+    ASSERT_EQ(expected_data_.size(), blocks.size());
+    EXPECT_TRUE(std::equal(expected_data_.begin(), expected_data_.end(), blocks.begin()));
+
+    // Check rank queries.
+    const size_t kSamplesCount = 9;
+    const size_t fraction = expected_data_.size() / kSamplesCount;
+    for (size_t i = 0; i <= kSamplesCount; ++i) {
+        const size_t k = std::min(i * fraction, expected_data_.size() - 1);
+        EXPECT_EQ(expected_data_[k], *blocks.k_statistics(k));
+        const size_t rank =
+            std::lower_bound(expected_data_.begin(), expected_data_.end(), expected_data_[k]) - expected_data_.begin();
+        EXPECT_EQ(rank, blocks.rank(expected_data_[k]));
+    }
+    EXPECT_TRUE(blocks.end() == blocks.k_statistics(blocks.size()));
+
+    // Erase the second half of the data back.
+    EXPECT_EQ(original_data_.size() - data_.size(),
+              blocks.erase(original_data_.begin() + data_.size(), original_data_.end()));
+    EXPECT_FALSE(blocks.erase(-1));
+    ASSERT_EQ(data_.size(), blocks.size());
+    EXPECT_TRUE(std::equal(data_.begin(), data_.end(), blocks.begin()));
+
+    // After heavy erasing, underfull blocks should be merged: each block keeps at least a quarter of the block size.
+    std::vector<int> erased = data_;
+    sort::shuffle(erased.begin(), erased.end());
+    erased.resize(erased.size() * 9 / 10);
+    EXPECT_EQ(erased.size(), blocks.erase(erased.begin(), erased.end()));
+    sort::eraseBatch(data_, erased.begin(), erased.end());
+    ASSERT_EQ(data_.size(), blocks.size());
+    EXPECT_TRUE(std::equal(data_.begin(), data_.end(), blocks.begin()));
+    EXPECT_LE(blocks.blocksCount(), blocks.size() * 4 / 64 + 1);
+    if (!data_.empty()) {
+        EXPECT_EQ(data_.back(), *blocks.k_statistics(data_.size() - 1));
+        const size_t rank = std::lower_bound(data_.begin(), data_.end(), data_.back()) - data_.begin();
+        EXPECT_EQ(rank, blocks.rank(data_.back()));
+    }
+}
+
+TEST(IncrementalEdgeCasesTest, Stability)
+{
+    struct StableNode
+    {
+        int value;
+        int order;
+        bool operator< (const StableNode& other) const { return value < other.value; }
+    };
+
+    // Equal elements should be kept in the order of insertion, both within and between batches.
+    std::srand(42u);
+    sort::SortedBlocks<StableNode> blocks(std::less<StableNode>(), 8);
+    std::vector<StableNode> data;
+    std::vector<StableNode> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.push_back(StableNode{std::rand() % 10, i});
+        if (batch.size() == 100) {
+            blocks.insert(batch.begin(), batch.end());
+            sort::insertBatch(data, batch.begin(), batch.end());
+            batch.clear();
+        }
+    }
+    ASSERT_EQ(1000u, blocks.size());
+    ASSERT_EQ(1000u, data.size());
+    auto previous = blocks.begin();
+    for (auto it = ++blocks.begin(); it != blocks.end(); ++it, ++previous) {
+        if (previous->value != it->value)
+            ASSERT_LT(previous->value, it->value);
+        else
+            ASSERT_LT(previous->order, it->order);
+    }
+    for (size_t i = 1; i < data.size(); ++i) {
+        if (data[i - 1].value != data[i].value)
+            ASSERT_LT(data[i - 1].value, data[i].value) << i;
+        else
+            ASSERT_LT(data[i - 1].order, data[i].order) << i;
+    }
+}
+
+// Test tracing of sorting phases.
+class TracingSortingTest : public UnstableSortingTest
+{
+protected:
+    void checkTracing(sort::tracing::Phase phase)
+    {
+        checkSorting();
+        const std::vector<sort::tracing::Event> events = sort::tracing::Recorder::events();
+        for (const sort::tracing::Event& event : events) {
+            EXPECT_EQ(phase, event.phase);
+            if (phase == sort::tracing::Phase::Partition) {
+                EXPECT_EQ(event.size, event.lesser + event.equal + event.greater);
+            }
+        }
+        // Top-level call should process all elements.
+        if (data_.size() > 1) {
+            EXPECT_TRUE(std::any_of(events.begin(), events.end(), [this](const sort::tracing::Event& event) {
+                return event.depth == 0 && event.size == data_.size(); }));
+        }
+
+        std::ostringstream trace;
+        sort::tracing::Recorder::dumpChromeTrace(trace);
+        EXPECT_EQ(0u, trace.str().find("{\"traceEvents\":["));
+        EXPECT_EQ(static_cast<double>(events.size()),
+                  summaryValue(std::string(sort::tracing::phaseName(phase)) + "_calls"));
+        if (phase == sort::tracing::Phase::Partition) {
+            // Each element, that is equal to some element before it, is a duplicate.
+            size_t duplicated = 0;
+            for (size_t i = 1; i < data_.size(); ++i)
+                duplicated += data_[i - 1] == data_[i];
+            EXPECT_NEAR(static_cast<double>(duplicated) / data_.size(), summaryValue("duplicate_ratio"), 1e-4);
+        }
+        sort::tracing::Recorder::clear();
+    }
+
+    double summaryValue(const std::string& key)
+    {
+        std::stringstream summary;
+        sort::tracing::Recorder::dumpSummary(summary);
+        std::string line_key;
+        double value;
+        while (summary >> line_key >> value) {
+            if (line_key == key)
+                return value;
+        }
+        ADD_FAILURE() << "No summary value for " << key;
+        return 0.0;
+    }
+};
+
+INSTANTIATE_TEST_CASE_P(IntegerInput, TracingSortingTest,
+                        ::testing::Values("data/sorting/all_duplicates.txt",
+                                          "data/sorting/highly_duplicated.txt",
+                                          "data/sorting/single_number.txt",
+                                          "data/sorting/unique_1.txt"));
+
+TEST_P(TracingSortingTest, Quicksort)
+{
+    prepareSortingTest();
+    sort::quick(data_.begin(), data_.end(), std::less<int>(), sort::tracing::Recorder());
+    checkTracing(sort::tracing::Phase::Partition);
+}
+
+TEST_P(TracingSortingTest, DuplicateRatio)
+{
+    prepareSortingTest();
+    sort::quick(data_.begin(), data_.end(), std::less<int>(), sort::tracing::Recorder());
+    const std::string input = GetParam();
+    // 10000 numbers with 100 distinct values, and unique numbers.
+    if (input == "data/sorting/highly_duplicated.txt") {
+        EXPECT_NEAR(0.99, summaryValue("duplicate_ratio"), 0.001);
+    } else if (input == "data/sorting/unique_1.txt") {
+        EXPECT_EQ(0.0, summaryValue("duplicate_ratio"));
+    }
+    sort::tracing::Recorder::clear();
+    checkSorting();
+}
+
+TEST_P(TracingSortingTest, Merge)
+{
+    prepareSortingTest();
+    sort::merge(data_.begin(), data_.end(), std::less<int>(), sort::tracing::Recorder());
+    checkTracing(sort::tracing::Phase::Merge);
+}
+
+TEST_P(TracingSortingTest, Heapsort)
+{
+    prepareSortingTest();
+    sort::heap(data_.begin(), data_.end(), std::less<int>(), sort::tracing::Recorder());
+    const std::vector<sort::tracing::Event> events = sort::tracing::Recorder::events();
+    if (data_.size() > 1) {
+        ASSERT_EQ(2u, events.size());
+        EXPECT_EQ(sort::tracing::Phase::HeapBuild, events[0].phase);
+        EXPECT_EQ(sort::tracing::Phase::HeapExtract, events[1].phase);
+    }
+    sort::tracing::Recorder::clear();
+    checkSorting();
+}
@@ -2,36 +2,55 @@
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <string>
 #include <vector>
 
 int main(int argc, char**argv)
 {
     const std::string help_text = R"(
-Required arguments: K N filename, where:
+Required arguments: [-s] K N filename, where:
+ - -s : optional flag, generate strings instead of numbers.
  - K : integer, upper bound of generated numbers interval [0, k). For K <= 0, unique numbers from [0, N) will be generated.
- - N : integer, total count of generated numbers.
- - filename : string, name of file to output numbers.)";
-    if (argc != 4) {
+       For strings, maximal length of the random part from [1, K], that follows an optional URL-like head of up to 17
+       characters.
+ - N : integer, total count of generated numbers or strings.
+ - filename : string, name of file to output numbers or strings.)";
+    const bool strings_mode = argc == 5 && std::string(argv[1]) == "-s";
+    if (argc != 4 && !strings_mode) {
         std::cout << help_text.c_str() << std::endl;
         return 1;
     }
+    if (strings_mode)
+        ++argv;
 
     const int K = atoi(argv[1]);
     const int N = atoi(argv[2]);
-    std::vector<int> numbers(N);
-    if (K > 0) {
-        for (int& number : numbers)
-            number = rand() % K;
-    } else {
-        for (int i = 0; i < N; ++i)
-            numbers[i] = i;
-        std::random_shuffle(numbers.begin(), numbers.end());
-    }
-
     std::ofstream output_stream(argv[3], std::ofstream::out);
     output_stream << N << std::endl;
-    for (int number : numbers)
-        output_stream << number << " ";
+    if (strings_mode) {
+        // Small alphabet and shared heads make long common prefixes and duplicates, like in URLs or log keys.
+        const std::string alphabet = "abcd";
+        const std::vector<std::string> heads = {"", "http://", "http://host/", "http://host/path/"};
+        for (int i = 0; i < N; ++i) {
+            std::string value = heads[rand() % heads.size()];
+            const int length = 1 + rand() % std::max(K, 1);
+            for (int j = 0; j < length; ++j)
+                value += alphabet[rand() % alphabet.size()];
+            output_stream << value << " ";
+        }
+    } else {
+        std::vector<int> numbers(N);
+        if (K > 0) {
+            for (int& number : numbers)
+                number = rand() % K;
+        } else {
+            for (int i = 0; i < N; ++i)
+                numbers[i] = i;
+            std::random_shuffle(numbers.begin(), numbers.end());
+        }
+        for (int number : numbers)
+            output_stream << number << " ";
+    }
     output_stream << std::endl;
     output_stream.close();
 